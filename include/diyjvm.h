@@ -50,12 +50,19 @@ extern bool debug_mode;
 #define CONSTANT_NameAndType         12
 #define CONSTANT_Utf8                1
 
+typedef struct {
+    uint16_t start_pc;
+    uint16_t line_number;
+} line_number_entry;
+
 typedef struct {
     uint16_t max_stack;
     uint16_t max_locals;
     uint32_t code_length;
     uint8_t *code;
-    // For brevity, we skip the rest (exception table, inner attributes, etc.)
+    uint16_t line_number_table_length;
+    line_number_entry *line_number_table; // From LineNumberTable, in file order
+    // For brevity, we skip the rest (exception table, other inner attributes, etc.)
 } code_attribute;
 
 typedef struct {
@@ -121,4 +128,14 @@ ClassFile *read_class_file(const char *filename);
 
 void free_class_file(ClassFile *cf);
 
+// Returns the Utf8 constant at index, or NULL if it is out of range or not Utf8
+const char *get_constant_utf8(const ClassFile *cf, uint16_t index);
+
+// Returns the source line for pc, or -1 if the method has no line number info
+// or no entry starts at or before pc
+int find_line_number(const code_attribute *code, uint32_t pc);
+
+// Prints each method as Class.nameDescriptor with its first source line
+void dump_methods(const ClassFile *cf, FILE *out);
+
 #endif //DIYJVM_H
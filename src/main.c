@@ -1,65 +1,144 @@
+// fileno() is POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
 #include "../include/diyjvm.h"
 #include <string.h>
+#include <sys/stat.h>
 
 bool debug_mode = false;
 
+// Class list recording (-l): every successfully loaded class, in load order,
+// written out by cleanup_vm(). The file is opened up front so a bad path
+// fails before any class is loaded.
+typedef struct {
+    char *name;
+    char *source;
+    uint64_t hash;
+} loaded_class;
+
+static const char *class_list_path = NULL;
+static FILE *class_list_file = NULL;
+static loaded_class *loaded_classes = NULL;
+static size_t loaded_classes_count = 0;
+static size_t loaded_classes_capacity = 0;
+
 // Class file parsing utilities
 
-static int safe_fread(void *buffer, size_t size, size_t count, FILE *fp) {
-    const size_t n = fread(buffer, size, count, fp);
-    if (n < count) {
-        // Could be EOF or an error
+// Class files are read into memory in one go and parsed from the buffer,
+// which avoids a stdio call for every u1/u2/u4 in the file.
+typedef struct {
+    const uint8_t *data;
+    size_t length;
+    size_t pos;
+} class_reader;
+
+static uint8_t *load_file(const char *filename, size_t *length) {
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) {
+        fprintf(stderr, "Error: Failed to open class file '%s'.\n", filename);
+        return NULL;
+    }
+
+    // Size the buffer from the open file itself so it cannot be swapped underneath us
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0) {
+        fprintf(stderr, "Error: Could not determine size of '%s'.\n", filename);
+        fclose(fp);
+        return NULL;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        fprintf(stderr, "Error: '%s' is not a regular file.\n", filename);
+        fclose(fp);
+        return NULL;
+    }
+
+    size_t size = (size_t) st.st_size;
+    uint8_t *data = malloc(size > 0 ? size : 1);
+    if (!data) {
+        fprintf(stderr, "Error: Out of memory reading '%s'.\n", filename);
+        fclose(fp);
+        return NULL;
+    }
+    if (fread(data, 1, size, fp) != size) {
         if (ferror(fp)) {
             fprintf(stderr, "Error: fread() encountered an I/O error.\n");
         } else {
             fprintf(stderr, "Error: Unexpected end of file.\n");
         }
+        free(data);
+        fclose(fp);
+        return NULL;
+    }
+
+    fclose(fp);
+    *length = size;
+    return data;
+}
+
+static int safe_read(class_reader *reader, void *buffer, size_t count) {
+    if (count > reader->length - reader->pos) {
+        fprintf(stderr, "Error: Unexpected end of file.\n");
+        return 0;
+    }
+    memcpy(buffer, reader->data + reader->pos, count);
+    reader->pos += count;
+    return 1;
+}
+
+static int skip_bytes(class_reader *reader, size_t count) {
+    if (count > reader->length - reader->pos) {
+        fprintf(stderr, "Error: Unexpected end of file.\n");
         return 0;
     }
+    reader->pos += count;
     return 1;
 }
 
-static uint32_t read_u4(FILE *fp, bool *ok) {
-    uint32_t value = 0;
-    if (!safe_fread(&value, 4, 1, fp)) {
+static uint32_t read_u4(class_reader *reader, bool *ok) {
+    if (reader->length - reader->pos < 4) {
+        fprintf(stderr, "Error: Unexpected end of file.\n");
         *ok = false;
         return 0;
     }
-    return __builtin_bswap32(value); // Convert from big-endian
+    // Class files are big-endian
+    const uint8_t *p = reader->data + reader->pos;
+    reader->pos += 4;
+    return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | p[3];
 }
 
-static uint16_t read_u2(FILE *fp, bool *ok) {
-    uint16_t value = 0;
-    if (!safe_fread(&value, 2, 1, fp)) {
+static uint16_t read_u2(class_reader *reader, bool *ok) {
+    if (reader->length - reader->pos < 2) {
+        fprintf(stderr, "Error: Unexpected end of file.\n");
         *ok = false;
         return 0;
     }
-    // Convert from big-endian
-    return __builtin_bswap16(value);
+    const uint8_t *p = reader->data + reader->pos;
+    reader->pos += 2;
+    return (uint16_t) (p[0] << 8 | p[1]);
 }
 
-static uint8_t read_u1(FILE *fp, bool *ok) {
-    uint8_t value = 0;
-    if (!safe_fread(&value, 1, 1, fp)) {
+static uint8_t read_u1(class_reader *reader, bool *ok) {
+    if (reader->pos >= reader->length) {
+        fprintf(stderr, "Error: Unexpected end of file.\n");
         *ok = false;
         return 0;
     }
-    return value;
+    return reader->data[reader->pos++];
 }
 
-static int read_constant_pool_entry(FILE *fp, cp_info *entry, bool *ok) {
-    entry->tag = read_u1(fp, ok);
+static int read_constant_pool_entry(class_reader *reader, cp_info *entry, bool *ok) {
+    entry->tag = read_u1(reader, ok);
     if (!*ok) return 0;
 
     DEBUG_PRINT("Reading constant pool entry with tag: %d\n", entry->tag);
 
     switch (entry->tag) {
         case CONSTANT_Class:
-            entry->info.class_info.name_index = read_u2(fp, ok);
+            entry->info.class_info.name_index = read_u2(reader, ok);
             break;
 
         case CONSTANT_Utf8: {
-            uint16_t length = read_u2(fp, ok);
+            uint16_t length = read_u2(reader, ok);
             if (!*ok) return 0;
 
             if (length > MAX_STRING_LENGTH) {
@@ -74,7 +153,7 @@ static int read_constant_pool_entry(FILE *fp, cp_info *entry, bool *ok) {
                 *ok = false;
                 return 0;
             }
-            if (!safe_fread(entry->info.utf8_info.bytes, 1, length, fp)) {
+            if (!safe_read(reader, entry->info.utf8_info.bytes, length)) {
                 *ok = false;
                 return 0;
             }
@@ -83,30 +162,30 @@ static int read_constant_pool_entry(FILE *fp, cp_info *entry, bool *ok) {
         }
 
         case CONSTANT_Integer:
-            entry->info.integer_info.bytes = read_u4(fp, ok);
+            entry->info.integer_info.bytes = read_u4(reader, ok);
             break;
 
         case CONSTANT_String:
-            entry->info.string_info.string_index = read_u2(fp, ok);
+            entry->info.string_info.string_index = read_u2(reader, ok);
             break;
 
         case CONSTANT_Fieldref:
         case CONSTANT_Methodref:
         case CONSTANT_InterfaceMethodref:
-            entry->info.methodref_info.class_index = read_u2(fp, ok);
-            entry->info.methodref_info.name_and_type_index = read_u2(fp, ok);
+            entry->info.methodref_info.class_index = read_u2(reader, ok);
+            entry->info.methodref_info.name_and_type_index = read_u2(reader, ok);
             break;
 
         case CONSTANT_NameAndType:
-            entry->info.nameandtype_info.name_index = read_u2(fp, ok);
-            entry->info.nameandtype_info.descriptor_index = read_u2(fp, ok);
+            entry->info.nameandtype_info.name_index = read_u2(reader, ok);
+            entry->info.nameandtype_info.descriptor_index = read_u2(reader, ok);
             break;
 
         case CONSTANT_Long:
         case CONSTANT_Double:
             // Each consumes 8 bytes
-            entry->info.long_info.high_bytes = read_u4(fp, ok);
-            entry->info.long_info.low_bytes = read_u4(fp, ok);
+            entry->info.long_info.high_bytes = read_u4(reader, ok);
+            entry->info.long_info.low_bytes = read_u4(reader, ok);
         // According to JVM spec, Long/Double uses two entries in the CP.
         // Return "2" so the loop can skip the next slot.
             return 2;
@@ -124,27 +203,155 @@ static int read_constant_pool_entry(FILE *fp, cp_info *entry, bool *ok) {
     return 1; // Normal case
 }
 
+// Appends one LineNumberTable attribute (attr_length bytes) to code's table;
+// a Code attribute may carry several. Returns 0 on malformed or truncated input.
+static int read_line_number_table(class_reader *reader, code_attribute *code, uint32_t attr_length) {
+    bool ok = true;
+    uint16_t table_length = read_u2(reader, &ok);
+    if (!ok) return 0;
+
+    if (attr_length != 2 + table_length * 4u) {
+        fprintf(stderr, "Error: LineNumberTable length %u does not match %u entries.\n",
+                attr_length, table_length);
+        return 0;
+    }
+    if (reader->length - reader->pos < table_length * 4u) {
+        fprintf(stderr, "Error: Unexpected end of file.\n");
+        return 0;
+    }
+    if (code->line_number_table_length + table_length > UINT16_MAX) {
+        fprintf(stderr, "Error: Too many line number entries in one method.\n");
+        return 0;
+    }
+    if (table_length == 0) return 1;
+
+    line_number_entry *table = realloc(code->line_number_table,
+        (code->line_number_table_length + table_length) * sizeof(line_number_entry));
+    if (!table) {
+        fprintf(stderr, "Error: Out of memory for line number table.\n");
+        return 0;
+    }
+    code->line_number_table = table;
+
+    // The bytes were checked above, so these reads cannot fail
+    for (int n = 0; n < table_length; n++) {
+        line_number_entry *entry = &table[code->line_number_table_length++];
+        entry->start_pc    = read_u2(reader, &ok);
+        entry->line_number = read_u2(reader, &ok);
+    }
+    return 1;
+}
+
+const char *get_constant_utf8(const ClassFile *cf, uint16_t index) {
+    if (index == 0 || index >= cf->constant_pool_count) return NULL;
+    const cp_info *entry = &cf->constant_pool[index];
+    if (entry->tag != CONSTANT_Utf8) return NULL;
+    return entry->info.utf8_info.bytes;
+}
+
+static const char *get_class_name(const ClassFile *cf) {
+    if (cf->this_class == 0 || cf->this_class >= cf->constant_pool_count) return NULL;
+    const cp_info *entry = &cf->constant_pool[cf->this_class];
+    if (entry->tag != CONSTANT_Class) return NULL;
+    return get_constant_utf8(cf, entry->info.class_info.name_index);
+}
+
+// 64-bit FNV-1a over the raw class file bytes
+static uint64_t hash_class_bytes(const uint8_t *data, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static void record_loaded_class(const ClassFile *cf, const char *source,
+                                const uint8_t *data, size_t length) {
+    if (!class_list_path) return;
+
+    if (loaded_classes_count == loaded_classes_capacity) {
+        size_t capacity = loaded_classes_capacity ? loaded_classes_capacity * 2 : 16;
+        loaded_class *grown = realloc(loaded_classes, capacity * sizeof(loaded_class));
+        if (!grown) {
+            fprintf(stderr, "Error: Out of memory recording class list.\n");
+            return;
+        }
+        loaded_classes = grown;
+        loaded_classes_capacity = capacity;
+    }
+
+    const char *name = get_class_name(cf);
+    loaded_class *entry = &loaded_classes[loaded_classes_count];
+    entry->name = strdup(name ? name : "<unknown>");
+    entry->source = strdup(source);
+    entry->hash = hash_class_bytes(data, length);
+    if (!entry->name || !entry->source) {
+        fprintf(stderr, "Error: Out of memory recording class list.\n");
+        SAFE_FREE(entry->name);
+        SAFE_FREE(entry->source);
+        return;
+    }
+    loaded_classes_count++;
+    DEBUG_PRINT("Recorded loaded class %s (hash %016llx)\n",
+                entry->name, (unsigned long long) entry->hash);
+}
+
+static bool open_class_list(const char *path) {
+    if (class_list_file) {
+        fclose(class_list_file); // a later -l replaces an earlier one
+    }
+    class_list_file = fopen(path, "w");
+    if (!class_list_file) {
+        fprintf(stderr, "Error: Failed to open class list '%s' for writing.\n", path);
+        return false;
+    }
+    class_list_path = path;
+    return true;
+}
+
+// Returns false if the list was requested but could not be written
+static bool write_class_list(void) {
+    if (!class_list_file) return true;
+
+    FILE *out = class_list_file;
+    class_list_file = NULL;
+    // Tab-separated with the source last, so paths containing spaces stay parseable
+    fprintf(out, "# diyJVM class list: <class name>\t<fnv1a-64 of class bytes>\t<source>\n");
+    for (size_t i = 0; i < loaded_classes_count; i++) {
+        fprintf(out, "%s\t%016llx\t%s\n", loaded_classes[i].name,
+                (unsigned long long) loaded_classes[i].hash, loaded_classes[i].source);
+    }
+    bool write_failed = ferror(out);
+    if (fclose(out) != 0 || write_failed) {
+        fprintf(stderr, "Error: Failed to write class list '%s'.\n", class_list_path);
+        return false;
+    }
+    DEBUG_PRINT("Wrote %zu classes to %s\n", loaded_classes_count, class_list_path);
+    return true;
+}
+
 ClassFile *read_class_file(const char *filename) {
     DEBUG_PRINT("Opening class file: %s\n", filename);
 
-    FILE *file = fopen(filename, "rb");
-    if (!file) {
-        char error_msg[256];
-        snprintf(error_msg, sizeof(error_msg), "Failed to open class file '%s'.", filename);
-        ERROR_AND_CLEANUP(error_msg, { /* no cleanup needed here */ });
+    size_t length = 0;
+    uint8_t *data = load_file(filename, &length);
+    if (!data) {
+        return NULL; // load_file() has already reported why
     }
 
+    class_reader reader = { .data = data, .length = length, .pos = 0 };
     bool ok = true;
     ClassFile *cf = malloc(sizeof(ClassFile));
     if (!cf) {
         ERROR_AND_CLEANUP("Out of memory allocating ClassFile.", {
-            fclose(file);
+            free(data);
         });
     }
     memset(cf, 0, sizeof(*cf)); // zero out structure
 
     // Read magic
-    cf->magic = read_u4(file, &ok);
+    cf->magic = read_u4(&reader, &ok);
     DEBUG_PRINT("Read magic number: 0x%08X\n", cf->magic);
     if (!ok || cf->magic != JAVA_MAGIC) {
         char error_msg[256];
@@ -152,35 +359,35 @@ ClassFile *read_class_file(const char *filename) {
                  "Invalid or missing magic number in '%s'.", filename);
         ERROR_AND_CLEANUP(error_msg, {
             free_class_file(cf);
-            fclose(file);
+            free(data);
         });
     }
     DEBUG_PRINT("Magic number verified successfully\n");
 
     // Read minor/major version
-    cf->minor_version = read_u2(file, &ok);
-    cf->major_version = read_u2(file, &ok);
+    cf->minor_version = read_u2(&reader, &ok);
+    cf->major_version = read_u2(&reader, &ok);
     if (!ok) {
         ERROR_AND_CLEANUP("Could not read version numbers.", {
             free_class_file(cf);
-            fclose(file);
+            free(data);
         });
     }
 
     if (cf->major_version < 45 || cf->major_version > 69) {
         ERROR_AND_CLEANUP("Unsupported class file version.", {
             free_class_file(cf);
-            fclose(file);
+            free(data);
         });
     }
 
     // Read constant pool count
-    cf->constant_pool_count = read_u2(file, &ok);
+    cf->constant_pool_count = read_u2(&reader, &ok);
     DEBUG_PRINT("Constant pool count: %d\n", cf->constant_pool_count);
     if (!ok || cf->constant_pool_count > MAX_CONSTANT_POOL_SIZE) {
         ERROR_AND_CLEANUP("Invalid constant pool count.", {
             free_class_file(cf);
-            fclose(file);
+            free(data);
         });
     }
 
@@ -188,69 +395,69 @@ ClassFile *read_class_file(const char *filename) {
     if (!cf->constant_pool) {
         ERROR_AND_CLEANUP("Out of memory allocating constant pool.", {
             free_class_file(cf);
-            fclose(file);
+            free(data);
         });
     }
 
     // Read each CP entry
     for (int i = 1; i < cf->constant_pool_count;) {
-        int step = read_constant_pool_entry(file, &cf->constant_pool[i], &ok);
+        int step = read_constant_pool_entry(&reader, &cf->constant_pool[i], &ok);
         if (!ok || step == 0) {
             char error_msg[256];
             snprintf(error_msg, sizeof(error_msg),
                      "Failed reading constant pool entry at index %d.", i);
             ERROR_AND_CLEANUP(error_msg, {
                 free_class_file(cf);
-                fclose(file);
+                free(data);
             });
         }
         i += step; // account for LONG/DOUBLE
     }
 
     // Read access_flags, this_class, super_class
-    cf->access_flags = read_u2(file, &ok);
-    cf->this_class   = read_u2(file, &ok);
-    cf->super_class  = read_u2(file, &ok);
+    cf->access_flags = read_u2(&reader, &ok);
+    cf->this_class   = read_u2(&reader, &ok);
+    cf->super_class  = read_u2(&reader, &ok);
     if (!ok) {
         ERROR_AND_CLEANUP("Could not read class header (flags/this/super).", {
             free_class_file(cf);
-            fclose(file);
+            free(data);
         });
     }
 
     // Interfaces
-    cf->interfaces_count = read_u2(file, &ok);
+    cf->interfaces_count = read_u2(&reader, &ok);
     if (!ok) {
         ERROR_AND_CLEANUP("Could not read interfaces_count.", {
             free_class_file(cf);
-            fclose(file);
+            free(data);
         });
     }
     if (cf->interfaces_count > 0) {
         long skipBytes = cf->interfaces_count * 2L;
-        if (fseek(file, skipBytes, SEEK_CUR) != 0) {
-            ERROR_AND_CLEANUP("Seek failed when skipping interfaces.", {
+        if (!skip_bytes(&reader, skipBytes)) {
+            ERROR_AND_CLEANUP("Truncated interfaces table.", {
                 free_class_file(cf);
-                fclose(file);
+                free(data);
             });
         }
     }
 
     // Fields
-    cf->fields_count = read_u2(file, &ok);
+    cf->fields_count = read_u2(&reader, &ok);
     if (!ok) {
         ERROR_AND_CLEANUP("Could not read fields_count.", {
             free_class_file(cf);
-            fclose(file);
+            free(data);
         });
     }
 
     // Skip over field details entirely (minimal example)
     for (int i = 0; i < cf->fields_count; i++) {
-        uint16_t field_access     = read_u2(file, &ok);
-        uint16_t field_name       = read_u2(file, &ok);
-        uint16_t field_desc       = read_u2(file, &ok);
-        uint16_t field_attr_count = read_u2(file, &ok);
+        uint16_t field_access     = read_u2(&reader, &ok);
+        uint16_t field_name       = read_u2(&reader, &ok);
+        uint16_t field_desc       = read_u2(&reader, &ok);
+        uint16_t field_attr_count = read_u2(&reader, &ok);
 
         DEBUG_PRINT("Field %d: access_flags=0x%04X, name_index=%d, descriptor_index=%d, attributes_count=%d\n",
                     i, field_access, field_name, field_desc, field_attr_count);
@@ -258,38 +465,38 @@ ClassFile *read_class_file(const char *filename) {
         if (!ok) {
             ERROR_AND_CLEANUP("Could not read field info.", {
                 free_class_file(cf);
-                fclose(file);
+                free(data);
             });
         }
 
         // Skip all attributes of this field
         for (int j = 0; j < field_attr_count; ++j) {
-            uint16_t attr_name_index = read_u2(file, &ok);
-            uint32_t attr_length     = read_u4(file, &ok);
+            uint16_t attr_name_index = read_u2(&reader, &ok);
+            uint32_t attr_length     = read_u4(&reader, &ok);
             DEBUG_PRINT("Field %d, Attribute %d: name_index=%d, length=%d\n",
                         i, j, attr_name_index, attr_length);
             if (!ok) {
                 ERROR_AND_CLEANUP("Error reading field attribute name/length.", {
                     free_class_file(cf);
-                    fclose(file);
+                    free(data);
                 });
             }
-            if (fseek(file, attr_length, SEEK_CUR) != 0) {
-                ERROR_AND_CLEANUP("Seek failed skipping field attribute.", {
+            if (!skip_bytes(&reader, attr_length)) {
+                ERROR_AND_CLEANUP("Truncated field attribute.", {
                     free_class_file(cf);
-                    fclose(file);
+                    free(data);
                 });
             }
         }
     }
 
     // Methods
-    cf->methods_count = read_u2(file, &ok);
+    cf->methods_count = read_u2(&reader, &ok);
     DEBUG_PRINT("Methods count: %d\n", cf->methods_count);
     if (!ok) {
         ERROR_AND_CLEANUP("Could not read methods_count.", {
             free_class_file(cf);
-            fclose(file);
+            free(data);
         });
     }
 
@@ -300,7 +507,7 @@ ClassFile *read_class_file(const char *filename) {
                  "Method count %u is suspiciously large.", cf->methods_count);
         ERROR_AND_CLEANUP(error_msg, {
             free_class_file(cf);
-            fclose(file);
+            free(data);
         });
     }
 
@@ -308,16 +515,16 @@ ClassFile *read_class_file(const char *filename) {
     if (!cf->methods) {
         ERROR_AND_CLEANUP("Out of memory allocating methods.", {
             free_class_file(cf);
-            fclose(file);
+            free(data);
         });
     }
 
     for (int i = 0; i < cf->methods_count; i++) {
         method_info *method = &cf->methods[i];
-        method->access_flags     = read_u2(file, &ok);
-        method->name_index       = read_u2(file, &ok);
-        method->descriptor_index = read_u2(file, &ok);
-        method->attributes_count = read_u2(file, &ok);
+        method->access_flags     = read_u2(&reader, &ok);
+        method->name_index       = read_u2(&reader, &ok);
+        method->descriptor_index = read_u2(&reader, &ok);
+        method->attributes_count = read_u2(&reader, &ok);
 
         DEBUG_PRINT("Method[%d]: access=0x%04X, name_index=%d, desc_index=%d, attr_count=%d\n",
                     i, method->access_flags, method->name_index,
@@ -326,18 +533,18 @@ ClassFile *read_class_file(const char *filename) {
         if (!ok) {
             ERROR_AND_CLEANUP("Could not read method info.", {
                 free_class_file(cf);
-                fclose(file);
+                free(data);
             });
         }
 
         // Check each method attribute
         for (int j = 0; j < method->attributes_count; j++) {
-            uint16_t attribute_name_index = read_u2(file, &ok);
-            uint32_t attr_length = read_u4(file, &ok);
+            uint16_t attribute_name_index = read_u2(&reader, &ok);
+            uint32_t attr_length = read_u4(&reader, &ok);
             if (!ok) {
                 ERROR_AND_CLEANUP("Error reading attribute name index/length for method attribute.", {
                     free_class_file(cf);
-                    fclose(file);
+                    free(data);
                 });
             }
 
@@ -352,19 +559,19 @@ ClassFile *read_class_file(const char *filename) {
                     if (!method->code_attribute) {
                         ERROR_AND_CLEANUP("Out of memory for code_attribute.", {
                             free_class_file(cf);
-                            fclose(file);
+                            free(data);
                         });
                     }
 
                     code_attribute *code = method->code_attribute;
-                    code->max_stack  = read_u2(file, &ok);
-                    code->max_locals = read_u2(file, &ok);
-                    code->code_length = read_u4(file, &ok);
+                    code->max_stack  = read_u2(&reader, &ok);
+                    code->max_locals = read_u2(&reader, &ok);
+                    code->code_length = read_u4(&reader, &ok);
 
                     if (!ok) {
                         ERROR_AND_CLEANUP("Could not read code_attribute core fields.", {
                             free_class_file(cf);
-                            fclose(file);
+                            free(data);
                         });
                     }
 
@@ -372,64 +579,76 @@ ClassFile *read_class_file(const char *filename) {
                     if (!code->code) {
                         ERROR_AND_CLEANUP("Out of memory for method code.", {
                             free_class_file(cf);
-                            fclose(file);
+                            free(data);
                         });
                     }
-                    if (!safe_fread(code->code, 1, code->code_length, file)) {
+                    if (!safe_read(&reader, code->code, code->code_length)) {
                         ERROR_AND_CLEANUP("Could not read code bytes.", {
                             free_class_file(cf);
-                            fclose(file);
+                            free(data);
                         });
                     }
 
-                    uint16_t exception_table_length = read_u2(file, &ok);
+                    uint16_t exception_table_length = read_u2(&reader, &ok);
                     if (!ok) {
                         ERROR_AND_CLEANUP("Could not read exception_table_length.", {
                             free_class_file(cf);
-                            fclose(file);
+                            free(data);
                         });
                     }
                     long skipBytes = exception_table_length * 8L;
-                    if (fseek(file, skipBytes, SEEK_CUR) != 0) {
-                        ERROR_AND_CLEANUP("Seek failed skipping exception table.", {
+                    if (!skip_bytes(&reader, skipBytes)) {
+                        ERROR_AND_CLEANUP("Truncated exception table.", {
                             free_class_file(cf);
-                            fclose(file);
+                            free(data);
                         });
                     }
 
-                    uint16_t code_attr_count = read_u2(file, &ok);
+                    uint16_t code_attr_count = read_u2(&reader, &ok);
                     if (!ok) {
                         ERROR_AND_CLEANUP("Could not read code attribute_count.", {
                             free_class_file(cf);
-                            fclose(file);
+                            free(data);
                         });
                     }
 
-                    // Skip sub-attributes of Code
+                    // Keep LineNumberTable, skip the other sub-attributes of Code
                     for (int k = 0; k < code_attr_count; k++) {
-                        uint16_t sub_attr_name_idx = read_u2(file, &ok);
-                        uint32_t sub_attr_len      = read_u4(file, &ok);
+                        uint16_t sub_attr_name_idx = read_u2(&reader, &ok);
+                        uint32_t sub_attr_len      = read_u4(&reader, &ok);
                         DEBUG_PRINT("Method[%d], Code attribute, Sub-attribute %d: name_index=%d, length=%d\n",
                                     i, k, sub_attr_name_idx, sub_attr_len);
                         if (!ok) {
                             ERROR_AND_CLEANUP("Error reading code sub-attribute name/length in Code attribute.", {
                                 free_class_file(cf);
-                                fclose(file);
+                                free(data);
                             });
                         }
-                        if (fseek(file, sub_attr_len, SEEK_CUR) != 0) {
-                            ERROR_AND_CLEANUP("Seek failed skipping sub-attribute in Code.", {
+
+                        const char *sub_attr_name = get_constant_utf8(cf, sub_attr_name_idx);
+                        if (sub_attr_name && strcmp(sub_attr_name, "LineNumberTable") == 0) {
+                            if (!read_line_number_table(&reader, code, sub_attr_len)) {
+                                ERROR_AND_CLEANUP("Malformed LineNumberTable attribute.", {
+                                    free_class_file(cf);
+                                    free(data);
+                                });
+                            }
+                            continue;
+                        }
+
+                        if (!skip_bytes(&reader, sub_attr_len)) {
+                            ERROR_AND_CLEANUP("Truncated sub-attribute in Code.", {
                                 free_class_file(cf);
-                                fclose(file);
+                                free(data);
                             });
                         }
                     }
                 } else {
                     // Skip unknown method attribute
-                    if (fseek(file, attr_length, SEEK_CUR) != 0) {
-                        ERROR_AND_CLEANUP("Seek failed skipping unknown method attribute.", {
+                    if (!skip_bytes(&reader, attr_length)) {
+                        ERROR_AND_CLEANUP("Truncated method attribute.", {
                             free_class_file(cf);
-                            fclose(file);
+                            free(data);
                         });
                     }
                 }
@@ -437,13 +656,15 @@ ClassFile *read_class_file(const char *filename) {
                 // attribute_name_index is out of valid range
                 ERROR_AND_CLEANUP("attribute_name_index out of range.", {
                     free_class_file(cf);
-                    fclose(file);
+                    free(data);
                 });
             }
         }
     }
 
-    fclose(file);
+    record_loaded_class(cf, filename, data, length);
+
+    free(data);
     return cf;
 }
 
@@ -466,6 +687,7 @@ void free_class_file(ClassFile *cf) {
             method_info *method = &cf->methods[i];
             if (method->code_attribute) {
                 SAFE_FREE(method->code_attribute->code);
+                SAFE_FREE(method->code_attribute->line_number_table);
                 SAFE_FREE(method->code_attribute);
             }
         }
@@ -476,46 +698,113 @@ void free_class_file(ClassFile *cf) {
     SAFE_FREE(cf);
 }
 
+int find_line_number(const code_attribute *code, uint32_t pc) {
+    if (!code) return -1;
+
+    // Entries are not required to be sorted; take the closest start_pc at or before pc
+    int line = -1;
+    uint32_t best_pc = 0;
+    for (int i = 0; i < code->line_number_table_length; i++) {
+        const line_number_entry *entry = &code->line_number_table[i];
+        if (entry->start_pc <= pc && (line < 0 || entry->start_pc >= best_pc)) {
+            best_pc = entry->start_pc;
+            line = entry->line_number;
+        }
+    }
+    return line;
+}
+
+void dump_methods(const ClassFile *cf, FILE *out) {
+    const char *class_name = get_class_name(cf);
+    fprintf(out, "Methods of %s:\n", class_name ? class_name : "<unknown>");
+
+    for (int i = 0; i < cf->methods_count; i++) {
+        const method_info *method = &cf->methods[i];
+        const char *name = get_constant_utf8(cf, method->name_index);
+        const char *descriptor = get_constant_utf8(cf, method->descriptor_index);
+        fprintf(out, "    %s.%s%s", class_name ? class_name : "<unknown>",
+                name ? name : "<unknown>", descriptor ? descriptor : "");
+
+        int line = find_line_number(method->code_attribute, 0);
+        if (line >= 0) {
+            fprintf(out, " (line %d)\n", line);
+        } else if (method->code_attribute) {
+            fprintf(out, " (unknown line)\n");
+        } else {
+            fprintf(out, " (no code)\n");
+        }
+    }
+}
+
 static void initialize_vm(void) {
     DEBUG_PRINT("Initializing diyJVM...\n");
 }
 
-static void cleanup_vm(void) {
+// Returns false if any shutdown output (the class list) could not be written
+static bool cleanup_vm(void) {
     DEBUG_PRINT("Cleaning up diyJVM...\n");
+
+    bool ok = write_class_list();
+    for (size_t i = 0; i < loaded_classes_count; i++) {
+        SAFE_FREE(loaded_classes[i].name);
+        SAFE_FREE(loaded_classes[i].source);
+    }
+    SAFE_FREE(loaded_classes);
+    loaded_classes_count = 0;
+    loaded_classes_capacity = 0;
+    return ok;
+}
+
+static void print_usage(const char *program) {
+    printf("Usage: %s [-d] [-l <file>] <class file>\n", program);
+    printf("Options:\n");
+    printf("  -d         Enable debug output\n");
+    printf("  -l <file>  Record loaded classes to <file> on exit\n");
 }
 
 int main(int argc, char *argv[]) {
-    if (argc < 2 || argc > 3) {
-        printf("Usage: %s [-d] <class file>\n", argv[0]);
-        printf("Options:\n");
-        printf("  -d    Enable debug output\n");
-        return 1;
+    int arg = 1;
+    while (arg < argc && argv[arg][0] == '-') {
+        if (strcmp(argv[arg], "-d") == 0) {
+            debug_mode = true;
+        } else if (strcmp(argv[arg], "-l") == 0 && arg + 1 < argc) {
+            if (!open_class_list(argv[++arg])) {
+                return 1;
+            }
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+        arg++;
     }
 
-    if (argc == 3 && strcmp(argv[1], "-d") == 0) {
-        debug_mode = true;
-        // shift argv so that argv[1] points to the <class file>
-        argv[1] = argv[2];
+    if (arg != argc - 1) {
+        print_usage(argv[0]);
+        return 1;
     }
+    const char *class_path = argv[arg];
 
     initialize_vm();
 
-    ClassFile *cf = read_class_file(argv[1]);
+    ClassFile *cf = read_class_file(class_path);
     if (!cf) {
-        fprintf(stderr, "Failed to read class file: %s\n", argv[1]);
+        fprintf(stderr, "Failed to read class file: %s\n", class_path);
         cleanup_vm();
         return 1;
     }
 
     // Basic info
-    printf("Class file: %s\n", argv[1]);
+    printf("Class file: %s\n", class_path);
     printf("Magic: 0x%08X\n", cf->magic);
     printf("Version: %d.%d\n", cf->major_version, cf->minor_version);
     printf("Constant pool entries: %d\n", cf->constant_pool_count);
     printf("Methods: %d\n", cf->methods_count);
 
+    if (debug_mode) {
+        dump_methods(cf, stderr);
+    }
+
     // Clean up
     free_class_file(cf);
-    cleanup_vm();
-    return 0;
+    return cleanup_vm() ? 0 : 1;
 }
\ No newline at end of file